@@ -0,0 +1,71 @@
+#include "levelpack.h"
+#include "bitboard.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+// Compares reachability kernels on every level of a pack.
+// Usage: bitboardbench [levelpack] [iterations]
+int main(int argc, char** argv)
+{
+  std::string const filename = argc > 1 ? argv[1] : "levels/AlbertoG_Plus2.txt";
+  int const iterations = argc > 2 ? std::atoi(argv[2]) : 10000;
+
+  LevelPack levelPack(filename);
+  std::vector<Board> boards;
+  for(LevelPack::Level const& level : levelPack.getLevels())
+  {
+    if(level.width <= Bitboard::MAX_WIDTH && level.height > 0)
+    {
+      boards.push_back(newBoard(level));
+    }
+  }
+
+  if(boards.empty())
+  {
+    std::cerr << "No usable levels in " << filename << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << levelPack.getName() << ": " << boards.size() << " levels, "
+            << iterations << " iterations" << std::endl;
+
+  ReachabilityKernel const kernels[] = { KERNEL_SCALAR, KERNEL_AVX2 };
+  for(ReachabilityKernel const kernel : kernels)
+  {
+    if(!kernelSupported(kernel))
+    {
+      std::cout << kernelName(kernel) << ": not supported on this CPU" << std::endl;
+      continue;
+    }
+
+    for(Board const& board : boards)
+    {
+      if(reachable(board, kernel) != reachable(board, KERNEL_SCALAR))
+      {
+        std::cerr << kernelName(kernel) << ": result differs from scalar kernel" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    std::size_t pushes = 0;
+    auto const start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i)
+    {
+      for(Board const& board : boards)
+      {
+        pushes += legalPushes(board, reachable(board, kernel)).size();
+      }
+    }
+    auto const end = std::chrono::steady_clock::now();
+
+    double const nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << kernelName(kernel) << ": "
+              << nanoseconds / (static_cast<double>(iterations) * boards.size())
+              << " ns per level (" << pushes / iterations << " pushes)" << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,341 @@
+#include "bitboard.h"
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QB_HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+  // Rows are padded to a multiple of this so the wide kernel never needs a tail loop
+  unsigned int const ROW_BLOCK = 4;
+
+  unsigned int paddedRows(unsigned int const height)
+  {
+    return 1 + (height + ROW_BLOCK - 1) / ROW_BLOCK * ROW_BLOCK + 1;
+  }
+
+  int lowestBit(std::uint64_t const bits)
+  {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int i = 0;
+    while(!(bits & (std::uint64_t(1) << i)))
+      ++i;
+    return i;
+#endif
+  }
+
+  std::uint64_t spreadRow(std::uint64_t r, std::uint64_t const passable)
+  {
+    std::uint64_t previous;
+    do
+    {
+      previous = r;
+      r = (r | (r << 1) | (r >> 1)) & passable;
+    } while(r != previous);
+    return r;
+  }
+
+  bool sweepScalar(std::uint64_t* reach, std::uint64_t const* passable, int const height, int const step)
+  {
+    bool changed = false;
+    int const first = step > 0 ? 0 : height - 1;
+    for(int y = first; y >= 0 && y < height; y += step)
+    {
+      std::uint64_t const r = spreadRow(reach[y] | ((reach[y - 1] | reach[y + 1]) & passable[y]), passable[y]);
+      if(r != reach[y])
+      {
+        reach[y] = r;
+        changed = true;
+      }
+    }
+    return changed;
+  }
+
+  void floodScalar(std::uint64_t* reach, std::uint64_t const* passable, int const height)
+  {
+    while(sweepScalar(reach, passable, height, 1) | sweepScalar(reach, passable, height, -1))
+    {
+    }
+  }
+
+#ifdef QB_HAVE_AVX2_KERNEL
+  __attribute__((target("avx2")))
+  __m256i spreadRowsAVX2(__m256i r, __m256i const passable)
+  {
+    r = _mm256_and_si256(r, passable);
+    __m256i const sides = _mm256_or_si256(_mm256_slli_epi64(r, 1), _mm256_srli_epi64(r, 1));
+    return _mm256_and_si256(_mm256_or_si256(r, sides), passable);
+  }
+
+  // Settles one block of four rows completely, moving reach between its
+  // lanes as well as in from the rows just above and below it
+  __attribute__((target("avx2")))
+  bool sweepAVX2(std::uint64_t* reach, std::uint64_t const* passable, int const blocks, int const step)
+  {
+    bool changed = false;
+    int const first = step > 0 ? 0 : blocks - 1;
+    for(int b = first; b >= 0 && b < blocks; b += step)
+    {
+      std::uint64_t* rows = reach + b * ROW_BLOCK;
+      __m256i const mask = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(passable + b * ROW_BLOCK));
+      __m256i const old = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(rows));
+      __m256i const above = _mm256_set1_epi64x(static_cast<long long>(rows[-1]));
+      __m256i const below = _mm256_set1_epi64x(static_cast<long long>(rows[ROW_BLOCK]));
+
+      __m256i r = old;
+      __m256i previous;
+      do
+      {
+        previous = r;
+        __m256i const up = _mm256_blend_epi32(_mm256_permute4x64_epi64(r, _MM_SHUFFLE(2, 1, 0, 0)), above, 0x03);
+        __m256i const down = _mm256_blend_epi32(_mm256_permute4x64_epi64(r, _MM_SHUFFLE(3, 3, 2, 1)), below, 0xC0);
+        r = spreadRowsAVX2(_mm256_or_si256(r, _mm256_or_si256(up, down)), mask);
+      } while(!_mm256_testc_si256(previous, r));
+
+      if(!_mm256_testc_si256(old, r))
+      {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows), r);
+        changed = true;
+      }
+    }
+    return changed;
+  }
+
+  void floodAVX2(std::uint64_t* reach, std::uint64_t const* passable, int const height)
+  {
+    int const blocks = (height + ROW_BLOCK - 1) / ROW_BLOCK;
+    while(sweepAVX2(reach, passable, blocks, 1) | sweepAVX2(reach, passable, blocks, -1))
+    {
+    }
+  }
+
+  bool detectAVX2()
+  {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+  }
+#endif
+}
+
+Bitboard::Bitboard() : width(0), height(0), rows(paddedRows(0), 0)
+{
+}
+
+Bitboard::Bitboard(const unsigned int width, const unsigned int height) :
+  width(width), height(height), rows(paddedRows(height), 0)
+{
+  if(width > MAX_WIDTH)
+  {
+    throw std::length_error("Bitboard wider than 64 columns");
+  }
+}
+
+bool Bitboard::get(const int x, const int y) const
+{
+  return x >= 0 && x < static_cast<int>(width) && (row(y) >> x) & 1;
+}
+
+void Bitboard::set(const int x, const int y)
+{
+  row(y) |= std::uint64_t(1) << x;
+}
+
+void Bitboard::clear(const int x, const int y)
+{
+  row(y) &= ~(std::uint64_t(1) << x);
+}
+
+int Bitboard::count() const
+{
+  int n = 0;
+  for(std::uint64_t r : rows)
+  {
+    for(; r; r &= r - 1)
+      ++n;
+  }
+  return n;
+}
+
+unsigned int Bitboard::getWidth() const
+{
+  return width;
+}
+
+unsigned int Bitboard::getHeight() const
+{
+  return height;
+}
+
+std::uint64_t Bitboard::row(const int y) const
+{
+  return y >= 0 && y < static_cast<int>(height) ? rows.at(y + 1) : 0;
+}
+
+std::uint64_t& Bitboard::row(const int y)
+{
+  return rows.at(y + 1);
+}
+
+std::uint64_t* Bitboard::data()
+{
+  return rows.data() + 1;
+}
+
+std::uint64_t const* Bitboard::data() const
+{
+  return rows.data() + 1;
+}
+
+bool Bitboard::operator==(const Bitboard& other) const
+{
+  return width == other.width && height == other.height && rows == other.rows;
+}
+
+bool Bitboard::operator!=(const Bitboard& other) const
+{
+  return !(*this == other);
+}
+
+Board newBoard(const LevelPack::Level& level)
+{
+  Board board;
+  board.floor = Bitboard(level.width, level.height);
+  board.boxes = Bitboard(level.width, level.height);
+  board.targets = Bitboard(level.width, level.height);
+
+  for(int y = 0; y < level.tiles.size(); ++y)
+  {
+    for(int x = 0; x < level.tiles.at(y).size(); ++x)
+    {
+      LevelPack::Level::Tile const tile = level.tiles.at(y).at(x);
+      if(tile == LevelPack::Level::NONE || tile == LevelPack::Level::WALL)
+        continue;
+
+      board.floor.set(x, y);
+
+      if(tile == LevelPack::Level::BOX)
+      {
+        board.boxes.set(x, y);
+      }
+      else if(tile == LevelPack::Level::TARGET)
+      {
+        board.targets.set(x, y);
+      }
+      else if(tile == LevelPack::Level::PLAYER)
+      {
+        board.playerX = x;
+        board.playerY = y;
+      }
+    }
+  }
+
+  return board;
+}
+
+bool kernelSupported(const ReachabilityKernel kernel)
+{
+  switch(kernel)
+  {
+    case KERNEL_AUTO: return true;
+    case KERNEL_SCALAR: return true;
+#ifdef QB_HAVE_AVX2_KERNEL
+    case KERNEL_AVX2:
+    {
+      static bool const supported = detectAVX2();
+      return supported;
+    }
+#endif
+    default: return false;
+  }
+}
+
+// The AVX2 kernel only breaks even with the scalar one on levels this
+// small (see bitboardbench), so it has to be asked for explicitly
+ReachabilityKernel bestKernel()
+{
+  return KERNEL_SCALAR;
+}
+
+char const* kernelName(const ReachabilityKernel kernel)
+{
+  switch(kernel)
+  {
+    case KERNEL_AUTO: return "auto";
+    case KERNEL_SCALAR: return "scalar";
+    case KERNEL_AVX2: return "avx2";
+    default: return "unknown";
+  }
+}
+
+Bitboard reachable(const Board& board, ReachabilityKernel kernel)
+{
+  unsigned int const height = board.floor.getHeight();
+  Bitboard passable(board.floor.getWidth(), height);
+  Bitboard reach(board.floor.getWidth(), height);
+
+  for(int y = 0; y < height; ++y)
+  {
+    passable.row(y) = board.floor.row(y) & ~board.boxes.row(y);
+  }
+
+  if(!passable.get(board.playerX, board.playerY))
+  {
+    return reach;
+  }
+
+  reach.set(board.playerX, board.playerY);
+
+  if(kernel == KERNEL_AUTO || !kernelSupported(kernel))
+  {
+    kernel = bestKernel();
+  }
+
+#ifdef QB_HAVE_AVX2_KERNEL
+  if(kernel == KERNEL_AVX2)
+  {
+    floodAVX2(reach.data(), passable.data(), height);
+    return reach;
+  }
+#endif
+
+  floodScalar(reach.data(), passable.data(), height);
+  return reach;
+}
+
+std::vector<Board::Push> legalPushes(const Board& board, const Bitboard& reach)
+{
+  std::vector<Board::Push> pushes;
+
+  for(int y = 0; y < board.boxes.getHeight(); ++y)
+  {
+    std::uint64_t const boxes = board.boxes.row(y);
+    if(!boxes)
+      continue;
+
+    // A push needs the player behind the box and free floor in front of it
+    std::uint64_t const freeAbove = board.floor.row(y - 1) & ~board.boxes.row(y - 1);
+    std::uint64_t const freeBelow = board.floor.row(y + 1) & ~board.boxes.row(y + 1);
+    std::uint64_t const freeHere = board.floor.row(y) & ~boxes;
+
+    std::uint64_t const candidates[] = {
+      boxes & reach.row(y + 1) & freeAbove,
+      boxes & reach.row(y - 1) & freeBelow,
+      boxes & (reach.row(y) >> 1) & (freeHere << 1),
+      boxes & (reach.row(y) << 1) & (freeHere >> 1)
+    };
+
+    for(int d = Board::UP; d <= Board::RIGHT; ++d)
+    {
+      for(std::uint64_t bits = candidates[d]; bits; bits &= bits - 1)
+      {
+        pushes.push_back({lowestBit(bits), y, static_cast<Board::Direction>(d)});
+      }
+    }
+  }
+
+  return pushes;
+}
@@ -0,0 +1,78 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "levelpack.h"
+#include <cstdint>
+#include <vector>
+
+// One 64-bit word per level row, bit x of a row is column x
+class Bitboard
+{
+public:
+  static unsigned int const MAX_WIDTH = 64;
+
+  Bitboard();
+  Bitboard(unsigned int const width, unsigned int const height);
+
+  bool get(int const x, int const y) const;
+  void set(int const x, int const y);
+  void clear(int const x, int const y);
+  int count() const;
+
+  unsigned int getWidth() const;
+  unsigned int getHeight() const;
+
+  // Row y, rows outside the level read as empty
+  std::uint64_t row(int const y) const;
+  std::uint64_t& row(int const y);
+
+  // Rows are stored with one empty guard row above and enough empty rows
+  // below to let kernels read and write four rows at a time
+  std::uint64_t* data();
+  std::uint64_t const* data() const;
+
+  bool operator==(Bitboard const& other) const;
+  bool operator!=(Bitboard const& other) const;
+
+private:
+  unsigned int width;
+  unsigned int height;
+  std::vector<std::uint64_t> rows;
+};
+
+struct Board
+{
+  enum Direction { UP, DOWN, LEFT, RIGHT };
+
+  struct Push
+  {
+    int x;
+    int y;
+    Direction direction;
+  };
+
+  Board() : floor(), boxes(), targets(), playerX(-1), playerY(-1) {}
+
+  Bitboard floor;
+  Bitboard boxes;
+  Bitboard targets;
+  int playerX;
+  int playerY;
+};
+
+enum ReachabilityKernel { KERNEL_AUTO, KERNEL_SCALAR, KERNEL_AVX2 };
+
+// Throws std::length_error for levels wider than Bitboard::MAX_WIDTH
+Board newBoard(LevelPack::Level const& level);
+
+bool kernelSupported(ReachabilityKernel const kernel);
+ReachabilityKernel bestKernel();
+char const* kernelName(ReachabilityKernel const kernel);
+
+// Squares the player can walk to without pushing
+Bitboard reachable(Board const& board, ReachabilityKernel const kernel = KERNEL_AUTO);
+
+// Pushes available to a player standing anywhere in the reachable set
+std::vector<Board::Push> legalPushes(Board const& board, Bitboard const& reach);
+
+#endif // BITBOARD_H
@@ -0,0 +1,124 @@
+#include "camera.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  float const FOV = 45.0f;
+  float const MARGIN = 1.0f;
+  // Levels with more rows than this are followed instead of shown whole
+  float const MAX_VISIBLE_ROWS = 16.0f;
+  // Fraction of the remaining distance covered per second, roughly
+  float const TWEEN_RATE = 4.0f;
+  float const SNAP_DISTANCE = 0.001f;
+
+  // Direction from the look-at point to the camera, tilted slightly towards the viewer
+  float const OFFSET_Y = 0.97f;
+  float const OFFSET_Z = 0.24f;
+
+  float visibleSpan(float const distance)
+  {
+    return 2.0f * distance * std::tan(FOV * 3.14159265f / 360.0f);
+  }
+
+  float centerOn(float const target, float const min, float const max, float const span)
+  {
+    if(max - min <= span)
+    {
+      return (min + max) / 2.0f;
+    }
+    return std::min(std::max(target, min + span / 2.0f), max - span / 2.0f);
+  }
+}
+
+CameraController::CameraController() :
+  camera(glhckCameraNew()), current({ 0.0f, 0.0f, 1.0f }),
+  minX(0.0f), minZ(0.0f), maxX(0.0f), maxZ(0.0f), followX(0.0f), followZ(0.0f),
+  width(0), height(0), placed(false), dirty(true)
+{
+  glhckCameraProjection(camera, GLHCK_PROJECTION_PERSPECTIVE);
+  glhckCameraRange(camera, 0.1f, 100.0f);
+  glhckCameraFov(camera, FOV);
+}
+
+CameraController::~CameraController()
+{
+  glhckCameraFree(camera);
+}
+
+glhckCamera* CameraController::getCamera() const
+{
+  return camera;
+}
+
+void CameraController::fit(const float minX, const float minZ, const float maxX, const float maxZ)
+{
+  this->minX = minX - MARGIN;
+  this->minZ = minZ - MARGIN;
+  this->maxX = maxX + MARGIN;
+  this->maxZ = maxZ + MARGIN;
+  followX = (minX + maxX) / 2.0f;
+  followZ = (minZ + maxZ) / 2.0f;
+}
+
+void CameraController::follow(const float x, const float z)
+{
+  followX = x;
+  followZ = z;
+}
+
+CameraController::View CameraController::desiredView() const
+{
+  float const aspect = height > 0 ? static_cast<float>(width) / height : 1.0f;
+  float const unitSpan = visibleSpan(1.0f);
+  float const fitDistance = std::max((maxZ - minZ) / unitSpan, (maxX - minX) / (unitSpan * aspect));
+  float const distance = std::min(fitDistance, MAX_VISIBLE_ROWS / unitSpan);
+  float const span = visibleSpan(distance);
+
+  View view;
+  view.x = centerOn(followX, minX, maxX, span * aspect);
+  view.z = centerOn(followZ, minZ, maxZ, span);
+  view.distance = distance;
+  return view;
+}
+
+void CameraController::update(const float delta, const int viewportWidth, const int viewportHeight)
+{
+  if(viewportWidth != width || viewportHeight != height)
+  {
+    width = viewportWidth;
+    height = viewportHeight;
+    glhckCameraViewporti(camera, 0, 0, width, height);
+    dirty = true;
+  }
+
+  View const desired = desiredView();
+  if(!placed)
+  {
+    current = desired;
+    placed = true;
+    dirty = true;
+  }
+  else if(std::fabs(desired.x - current.x) > SNAP_DISTANCE
+          || std::fabs(desired.z - current.z) > SNAP_DISTANCE
+          || std::fabs(desired.distance - current.distance) > SNAP_DISTANCE)
+  {
+    float const t = std::min(1.0f, delta * TWEEN_RATE);
+    current.x += (desired.x - current.x) * t;
+    current.z += (desired.z - current.z) * t;
+    current.distance += (desired.distance - current.distance) * t;
+    dirty = true;
+  }
+
+  if(!dirty)
+    return;
+
+  glhckObject* object = glhckCameraGetObject(camera);
+  glhckObjectPositionf(object,
+                       current.x,
+                       current.distance * OFFSET_Y,
+                       current.z + current.distance * OFFSET_Z);
+  glhckObjectTargetf(object, current.x, 0, current.z);
+  glhckCameraUpdate(camera);
+  dirty = false;
+}
@@ -0,0 +1,48 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include "glhck/glhck.h"
+
+// Looks down on a rectangle of the ground plane. Fits the whole rectangle
+// to the viewport when possible and otherwise follows a point inside it,
+// easing towards each new view. The glhck camera is only updated on frames
+// where the view or the viewport changed.
+class CameraController
+{
+public:
+  CameraController();
+  ~CameraController();
+
+  glhckCamera* getCamera() const;
+
+  // Bounds of the area to show, in world units on the x/z plane
+  void fit(float const minX, float const minZ, float const maxX, float const maxZ);
+  void follow(float const x, float const z);
+
+  void update(float const delta, int const viewportWidth, int const viewportHeight);
+
+private:
+  struct View
+  {
+    float x;
+    float z;
+    float distance;
+  };
+
+  View desiredView() const;
+
+  glhckCamera* camera;
+  View current;
+  float minX;
+  float minZ;
+  float maxX;
+  float maxZ;
+  float followX;
+  float followZ;
+  int width;
+  int height;
+  bool placed;
+  bool dirty;
+};
+
+#endif // CAMERA_H
@@ -1,6 +1,9 @@
 #include "game.h"
 #include "glhck/glhck.h"
 #include "gasxx.h"
+#include "moveanimation.h"
+#include "camera.h"
+#include "resources.h"
 
 #include <vector>
 #include <string>
@@ -18,6 +21,8 @@ struct Coordinates {
 };
 
 Coordinates DIRECTIONS[] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+char const DIRECTION_MOVES[] = "udlr";
+char const DIRECTION_PUSHES[] = "UDLR";
 float DIRECTION_ANGLES[] = {180, 0, 270, 90};
 
 struct Object {
@@ -28,10 +33,12 @@ struct Object {
   Type type;
   glhckObject* o;
   Direction facing;
+  MoveAnimator move;
   gas::Animation a;
+  gas::Animation idle;
 };
 
-Object const NO_OBJECT = { Object::NONE, nullptr, UP, gas::Animation::NONE };
+Object const NO_OBJECT = { Object::NONE, nullptr, UP, MoveAnimator(), gas::Animation::NONE, gas::Animation::NONE };
 
 struct Tile
 {
@@ -55,19 +62,30 @@ struct Level
 
 struct Game
 {
-  glhckCamera* camera;
+  CameraController* camera;
   Level level;
   bool animating;
+  float timeScale;
+  unsigned int scriptStep;
+  GameStatistics statistics;
 };
 
-glhckObject* texturedCube(float size, std::string const& textureFilename)
+struct MoveAnimations
+{
+  MoveAnimation walk[4][4];
+  MoveAnimation push[4][4];
+  MoveAnimation box[4];
+};
+
+glhckObject* texturedCube(float size, std::string const& textureFilename, Resource::Owner owner)
 {
   glhckObject* o = glhckCubeNew(size);
-  glhckTexture* texture = glhckTextureNewFromFile(textureFilename.data(), glhckImportDefaultImageParameters(), glhckTextureDefaultParameters());
-  glhckMaterial* material = glhckMaterialNew(texture);
+  glhckTexture* texture = trackTexture(glhckTextureNewFromFile(textureFilename.data(), glhckImportDefaultImageParameters(), glhckTextureDefaultParameters()), owner);
+  glhckMaterial* material = trackMaterial(glhckMaterialNew(texture), owner);
   glhckObjectMaterial(o, material);
-  glhckMaterialFree(material);
-  glhckTextureFree(texture);
+  trackObject(o, owner);
+  freeMaterial(material);
+  freeTexture(texture);
   return o;
 }
 
@@ -78,7 +96,7 @@ Tile newEmptyTile(int x, int y)
 
 Tile newFloorTile(int x, int y, Object const& object = NO_OBJECT)
 {
-  glhckObject* o = texturedCube(GRID_SIZE / 2.0f, "model/floor.jpg");
+  glhckObject* o = texturedCube(GRID_SIZE / 2.0f, "model/floor.jpg", Resource::FLOOR);
   glhckObjectPositionf(o, x * GRID_SIZE, -GRID_SIZE, y * GRID_SIZE);
   float brightness = (x + y) % 2 ? 224 : 255;
   glhckMaterialDiffuseb(glhckObjectGetMaterial(o), brightness, brightness, brightness, 255);
@@ -88,16 +106,15 @@ Tile newFloorTile(int x, int y, Object const& object = NO_OBJECT)
 
 Tile newWallTile(int x, int y)
 {
-  glhckObject* o = texturedCube(GRID_SIZE / 2.0f, "model/wall.jpg");
+  glhckObject* o = texturedCube(GRID_SIZE / 2.0f, "model/wall.jpg", Resource::WALL);
   glhckObjectPositionf(o, x * GRID_SIZE, 0, y * GRID_SIZE);
   Tile tile { Tile::WALL, NO_OBJECT, {x, y}, o };
   return tile;
 }
 Tile newTargetTile(int x, int y)
 {
-  glhckObject* o = glhckCubeNew(GRID_SIZE / 2.0f);
+  glhckObject* o = texturedCube(GRID_SIZE / 2.0f, "model/target.jpg", Resource::TARGET);
   glhckObjectPositionf(o, x * GRID_SIZE, -GRID_SIZE, y * GRID_SIZE);
-  glhckObjectMaterial(o, glhckMaterialNew(glhckTextureNewFromFile("model/target.jpg", glhckImportDefaultImageParameters(), glhckTextureDefaultParameters())));
   Tile tile { Tile::TARGET, NO_OBJECT, {x, y}, o };
   return tile;
 }
@@ -107,19 +124,20 @@ Object newPlayerObject(int x, int y)
   glhckImportModelParameters animatedParams = *glhckImportDefaultModelParameters();
   animatedParams.animated = 1;
 
-  glhckObject* o = glhckModelNew("model/pig.glhckm", GRID_SIZE, &animatedParams);
+  glhckObject* o = trackObject(glhckModelNew("model/pig.glhckm", GRID_SIZE, &animatedParams), Resource::PLAYER);
   glhckObjectPositionf(o, x * GRID_SIZE, -0.5, y * GRID_SIZE);
-  gas::Animation animation = gas::Animation::model("Stand", 10.0f);
-  animation.loop();
-  Object object { Object::PLAYER, o, DOWN, std::move(animation) };
+  gas::Animation idle = gas::Animation::model("Stand", 10.0f);
+  idle.loop();
+  trackAnimation(Resource::PLAYER);
+  Object object { Object::PLAYER, o, DOWN, MoveAnimator(), gas::Animation::NONE, std::move(idle) };
   return object;
 }
 
 Object newBoxObject(int x, int y)
 {
-  glhckObject* o = texturedCube(2 * GRID_SIZE / 5.0f, "model/box.png");
+  glhckObject* o = texturedCube(2 * GRID_SIZE / 5.0f, "model/box.png", Resource::BOX);
   glhckObjectPositionf(o, x * GRID_SIZE, 0, y * GRID_SIZE);
-  Object object { Object::BOX, o, UP, gas::Animation::NONE };
+  Object object { Object::BOX, o, UP, MoveAnimator(), gas::Animation::NONE, gas::Animation::NONE };
   return object;
 }
 
@@ -144,70 +162,100 @@ Tile& getTile(Game* game, int x, int y)
   return game->level.tiles.at(y).at(x);
 }
 
-gas::Animation pushAnimationBox(Direction direction)
+Resource::Owner resourceOwner(Object const& object)
+{
+  return object.type == Object::PLAYER ? Resource::PLAYER : Resource::BOX;
+}
+
+void clearClip(Object& object)
+{
+  if(object.a)
+  {
+    object.a = gas::Animation::NONE;
+    releaseAnimation(resourceOwner(object));
+  }
+}
+
+void playClip(Object& object, gas::Animation animation)
+{
+  clearClip(object);
+  object.a = std::move(animation);
+  trackAnimation(resourceOwner(object));
+}
+
+void freeObject(Object& object)
+{
+  clearClip(object);
+  if(object.idle)
+  {
+    object.idle = gas::Animation::NONE;
+    releaseAnimation(resourceOwner(object));
+  }
+  freeObject(object.o);
+  object = NO_OBJECT;
+}
+
+float turnAngle(Direction direction, Direction facing)
+{
+  float const rotation = DIRECTION_ANGLES[direction] - DIRECTION_ANGLES[facing];
+  return rotation > 180 ? rotation - 360 : rotation < -180 ? rotation + 360 : rotation;
+}
+
+MoveAnimation pushAnimationBox(Direction direction)
 {
   Coordinates& delta = DIRECTIONS[direction];
 
-  return gas::Animation::sequential({
-    gas::Animation::pause(0.1),
-    gas::Animation::parallel({
-     gas::Animation::delta(GAS_NUMBER_ANIMATION_TARGET_X, gasEasingLinear, delta.x * GRID_SIZE, 0.7),
-     gas::Animation::delta(GAS_NUMBER_ANIMATION_TARGET_Z, gasEasingLinear, delta.y * GRID_SIZE, 0.7)
-    }),
-    gas::Animation::pause(0.1)
-  });
+  return MoveAnimation()
+    .track(MoveAnimation::X, 0.1, 0.7, delta.x * GRID_SIZE)
+    .track(MoveAnimation::Z, 0.1, 0.7, delta.y * GRID_SIZE);
 }
 
-gas::Animation pushAnimationPlayer(Direction direction, Direction facing)
+MoveAnimation pushAnimationPlayer(Direction direction, Direction facing)
 {
   Coordinates& delta = DIRECTIONS[direction];
-  int const directionAngle = DIRECTION_ANGLES[direction];
-  int const facingAngle = DIRECTION_ANGLES[facing];
-  int const rotation = directionAngle - facingAngle > 180
-      ? (directionAngle - 360) - facingAngle
-      : directionAngle - facingAngle;
-
-  return gas::Animation::parallel({
-    gas::Animation::sequential({
-      gas::Animation::delta(GAS_NUMBER_ANIMATION_TARGET_ROT_Y, gasEasingLinear, rotation, 0.1),
-      gas::Animation::parallel({
-       gas::Animation::delta(GAS_NUMBER_ANIMATION_TARGET_X, gasEasingLinear, delta.x * GRID_SIZE/3, 0.1),
-       gas::Animation::delta(GAS_NUMBER_ANIMATION_TARGET_Z, gasEasingLinear, delta.y * GRID_SIZE/3, 0.1)
-      }),
-      gas::Animation::parallel({
-       gas::Animation::delta(GAS_NUMBER_ANIMATION_TARGET_X, gasEasingLinear, delta.x * GRID_SIZE, 0.7),
-       gas::Animation::delta(GAS_NUMBER_ANIMATION_TARGET_Z, gasEasingLinear, delta.y * GRID_SIZE, 0.7),
-      }),
-      gas::Animation::parallel({
-       gas::Animation::delta(GAS_NUMBER_ANIMATION_TARGET_X, gasEasingLinear, -delta.x * GRID_SIZE/3, 0.1),
-       gas::Animation::delta(GAS_NUMBER_ANIMATION_TARGET_Z, gasEasingLinear, -delta.y * GRID_SIZE/3, 0.1),
-      }),
-    }),
-    gas::Animation::model("Push", 1.0)
-  });
+
+  return MoveAnimation()
+    .track(MoveAnimation::ROTATION_Y, 0.0, 0.1, turnAngle(direction, facing))
+    .track(MoveAnimation::X, 0.1, 0.1, delta.x * GRID_SIZE/3)
+    .track(MoveAnimation::Z, 0.1, 0.1, delta.y * GRID_SIZE/3)
+    .track(MoveAnimation::X, 0.2, 0.7, delta.x * GRID_SIZE)
+    .track(MoveAnimation::Z, 0.2, 0.7, delta.y * GRID_SIZE)
+    .track(MoveAnimation::X, 0.9, 0.1, -delta.x * GRID_SIZE/3)
+    .track(MoveAnimation::Z, 0.9, 0.1, -delta.y * GRID_SIZE/3)
+    .clip("Push", 1.0);
 }
 
-gas::Animation walkAnimationPlayer(Direction direction, Direction facing)
+MoveAnimation walkAnimationPlayer(Direction direction, Direction facing)
 {
   Coordinates& delta = DIRECTIONS[direction];
-  int const directionAngle = DIRECTION_ANGLES[direction];
-  int const facingAngle = DIRECTION_ANGLES[facing];
-  int const rotation = directionAngle - facingAngle > 180
-      ? (directionAngle - 360) - facingAngle
-      : directionAngle - facingAngle;
-
-  return gas::Animation::parallel({
-    gas::Animation::delta(GAS_NUMBER_ANIMATION_TARGET_ROT_Y, gasEasingLinear, rotation, 0.1),
-    gas::Animation::delta(GAS_NUMBER_ANIMATION_TARGET_X, gasEasingLinear, delta.x * GRID_SIZE, 0.5),
-    gas::Animation::delta(GAS_NUMBER_ANIMATION_TARGET_Z, gasEasingLinear, delta.y * GRID_SIZE, 0.5),
-    gas::Animation::model("Run", 0.5)
-  });
+
+  return MoveAnimation()
+    .track(MoveAnimation::ROTATION_Y, 0.0, 0.1, turnAngle(direction, facing))
+    .track(MoveAnimation::X, 0.0, 0.5, delta.x * GRID_SIZE)
+    .track(MoveAnimation::Z, 0.0, 0.5, delta.y * GRID_SIZE)
+    .clip("Run", 0.5);
 }
 
-void animationComplete(glhckObject* object, void* userdata)
+MoveAnimations buildMoveAnimations()
 {
-  Game* game = static_cast<Game*>(userdata);
-  game->animating = false;
+  MoveAnimations animations;
+  Direction const directions[] = { UP, DOWN, LEFT, RIGHT };
+  for(Direction direction : directions)
+  {
+    for(Direction facing : directions)
+    {
+      animations.walk[direction][facing] = walkAnimationPlayer(direction, facing);
+      animations.push[direction][facing] = pushAnimationPlayer(direction, facing);
+    }
+    animations.box[direction] = pushAnimationBox(direction);
+  }
+  return animations;
+}
+
+MoveAnimations const& moveAnimations()
+{
+  static MoveAnimations const animations = buildMoveAnimations();
+  return animations;
 }
 
 void move(Game* game, Direction direction)
@@ -235,18 +283,22 @@ void move(Game* game, Direction direction)
     }
 
     pushing = true;
-    destinationTile.object.a = pushAnimationBox(direction);
+    destinationTile.object.move.start(moveAnimations().box[direction]);
     pushDestinationTile.object = std::move(destinationTile.object);
     destinationTile.object = NO_OBJECT;
   }
 
   game->animating = true;
+  game->statistics.moves += 1;
+  game->statistics.pushes += pushing ? 1 : 0;
+  game->statistics.solution += pushing ? DIRECTION_PUSHES[direction] : DIRECTION_MOVES[direction];
 
-  currentTile.object.a = gas::Animation::sequential({
-    pushing ? pushAnimationPlayer(direction, currentTile.object.facing) : walkAnimationPlayer(direction, currentTile.object.facing),
-    gas::Animation::action(animationComplete, game),
-    gas::Animation::model("Stand", 10.0f).loop()
-  });
+  Direction const facing = currentTile.object.facing;
+  MoveAnimation const& animation = pushing
+      ? moveAnimations().push[direction][facing]
+      : moveAnimations().walk[direction][facing];
+  currentTile.object.move.start(animation);
+  playClip(currentTile.object, gas::Animation::model(animation.getClip(), animation.getClipDuration()));
 
   currentTile.object.facing = direction;
   destinationTile.object = std::move(currentTile.object);
@@ -267,7 +319,7 @@ Tile createTile(LevelPack::Level::Tile const tile, int const x, int const y)
   }
 }
 
-void loadLevel(Game* game, LevelPack::Level const& level)
+void freeLevel(Game* game)
 {
   for(auto& row : game->level.tiles)
   {
@@ -275,19 +327,22 @@ void loadLevel(Game* game, LevelPack::Level const& level)
     {
       if(tile.type != Tile::NONE)
       {
-        glhckObjectFree(tile.o);
+        freeObject(tile.o);
       }
       if(tile.object.type != Object::NONE)
       {
-        glhckObjectFree(tile.object.o);
-      }
-      if(tile.object.a)
-      {
-        tile.object.a = gas::Animation::NONE;
+        freeObject(tile.object);
       }
     }
   }
 
+  game->level.tiles.clear();
+}
+
+void loadLevel(Game* game, LevelPack::Level const& level)
+{
+  freeLevel(game);
+
   game->level.width = level.width;
   game->level.height = level.height;
   game->level.name = level.name;
@@ -306,40 +361,50 @@ void loadLevel(Game* game, LevelPack::Level const& level)
 
   game->animating = false;
 
-  if(game->camera)
+  int minX = game->level.width;
+  int minY = game->level.height;
+  int maxX = 0;
+  int maxY = 0;
+  for(auto& row : game->level.tiles)
   {
-    glhckCameraFree(game->camera);
+    for(Tile const& tile : row)
+    {
+      if(tile.type != Tile::NONE)
+      {
+        minX = std::min(minX, tile.coordinates.x);
+        minY = std::min(minY, tile.coordinates.y);
+        maxX = std::max(maxX, tile.coordinates.x);
+        maxY = std::max(maxY, tile.coordinates.y);
+      }
+    }
   }
-  game->camera = glhckCameraNew();
-
-  glhckCameraProjection(game->camera, GLHCK_PROJECTION_PERSPECTIVE);
-  glhckObjectPositionf(glhckCameraGetObject(game->camera),
-                       game->level.width * GRID_SIZE / 2,
-                       game->level.width * GRID_SIZE * 2,
-                       (game->level.height * GRID_SIZE));
-  glhckObjectTargetf(glhckCameraGetObject(game->camera),
-                     game->level.width * GRID_SIZE / 2,
-                     0,
-                     game->level.height * GRID_SIZE / 2);
-
-  glhckCameraRange(game->camera, 0.1f, 100.0f);
-  glhckCameraFov(game->camera, 45);
-  glhckCameraUpdate(game->camera);
+
+  game->camera->fit(minX * GRID_SIZE, minY * GRID_SIZE, maxX * GRID_SIZE, maxY * GRID_SIZE);
 }
 
-Game* newGame(const LevelPack::Level& level)
+Game* newGame(const LevelPack::Level& level, CameraController& camera)
 {
   Game* game = new Game;
-  game->camera = nullptr;
+  game->camera = &camera;
+  game->timeScale = 1.0f;
+  game->scriptStep = 0;
+  game->statistics = GameStatistics();
 
   loadLevel(game, level);
 
   return game;
 }
 
-void playGame(Game* game, glfwContext& ctx)
+void playGame(Game* game, glfwContext& ctx, Renderer& renderer)
 {
-  if(!game->animating)
+  if(!game->animating && ctx.window == nullptr)
+  {
+    // Without a window there is no input, walk a fixed script instead.
+    // Steps advance per attempt so blocked moves do not stall the script.
+    Direction const SCRIPT[] = { UP, RIGHT, DOWN, LEFT };
+    move(game, SCRIPT[game->scriptStep++ % 4]);
+  }
+  else if(!game->animating)
   {
     if(glfwGetKey(ctx.window, GLFW_KEY_ESCAPE))
     {
@@ -363,23 +428,42 @@ void playGame(Game* game, glfwContext& ctx)
     }
   }
 
+  float const deltaTime = ctx.deltaTime * game->timeScale;
+  game->statistics.time += ctx.deltaTime;
+
   for(std::vector<Tile>& row : game->level.tiles)
   {
     for(Tile& tile : row)
     {
+      if(tile.object.move.animate(tile.object.o, deltaTime) && tile.object.type == Object::PLAYER)
+      {
+        game->animating = false;
+      }
+
       if(tile.object.a)
       {
-        tile.object.a.animate(tile.object.o, ctx.deltaTime);
+        tile.object.a.animate(tile.object.o, deltaTime);
         if(tile.object.a.getState() == GAS_ANIMATION_STATE_FINISHED)
         {
-          tile.object.a = gas::Animation::NONE;
+          clearClip(tile.object);
         }
       }
+      else if(tile.object.idle)
+      {
+        tile.object.idle.animate(tile.object.o, deltaTime);
+      }
     }
   }
 
-  glhckRenderClear(GLHCK_DEPTH_BUFFER_BIT | GLHCK_COLOR_BUFFER_BIT);
-  glhckCameraUpdate(game->camera);
+  Coordinates const player = findPlayer(game);
+  if(player.x >= 0)
+  {
+    kmVec3 const* position = glhckObjectGetPosition(getTile(game, player.x, player.y).object.o);
+    game->camera->follow(position->x, position->z);
+  }
+  game->camera->update(ctx.deltaTime, ctx.width, ctx.height);
+
+  renderer.begin();
 
   for(std::vector<Tile>& rows : game->level.tiles)
   {
@@ -387,18 +471,37 @@ void playGame(Game* game, glfwContext& ctx)
     {
       if(tile.type != Tile::NONE)
       {
-        glhckObjectDraw(tile.o);
+        renderer.draw(tile.o);
       }
       if(tile.object.type != Object::NONE)
       {
-        glhckObjectDraw(tile.object.o);
+        renderer.draw(tile.object.o);
       }
     }
   }
+
+  renderer.end();
+}
+
+GameStatistics const& getGameStatistics(Game* game)
+{
+  return game->statistics;
+}
+
+bool setGameTimeScale(Game* game, float timeScale)
+{
+  if(!(timeScale > 0.0f))
+  {
+    return false;
+  }
+
+  game->timeScale = timeScale;
+  return true;
 }
 
 void endGame(Game* game)
 {
+  freeLevel(game);
   delete game;
 }
 
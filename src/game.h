@@ -3,15 +3,29 @@
 
 #include "glfwcontext.h"
 #include "levelpack.h"
+#include "renderer.h"
+#include "camera.h"
 #include <iostream>
 #include <vector>
 #include <string>
 
 struct Game;
 
-Game* newGame(LevelPack::Level const& level);
-void playGame(Game* game, glfwContext& ctx);
+struct GameStatistics
+{
+  GameStatistics() : moves(0), pushes(0), time(0.0f), solution() {}
+  unsigned int moves;
+  unsigned int pushes;
+  float time;
+  std::string solution; // LURD notation, pushes in upper case
+};
+
+Game* newGame(LevelPack::Level const& level, CameraController& camera);
+void playGame(Game* game, glfwContext& ctx, Renderer& renderer);
 bool gameFinished(Game* game);
+GameStatistics const& getGameStatistics(Game* game);
+// Speeds up or slows down all animation, timeScale must be positive
+bool setGameTimeScale(Game* game, float timeScale);
 void endGame(Game* game);
 
 #endif // GAME_H
@@ -5,7 +5,7 @@
 
 struct glfwContext
 {
-  glfwContext(GLFWwindow* window) : running(true), window(window),
+  glfwContext(GLFWwindow* window) : running(true), window(window), width(0), height(0),
     totalTime(0.0f), deltaTime(0.0f), fps(0.0f), fpsTime(0.0f), fpsFrame(0),
     previousFrameStartTime(0.0f), previousFrameDuration(0.0f), frame(0)
   {
@@ -13,6 +13,8 @@ struct glfwContext
 
   bool running;
   GLFWwindow* window;
+  int width;
+  int height;
   float totalTime;
   float deltaTime;
   float fps;
@@ -3,22 +3,92 @@
 
 #include "glfwcontext.h"
 #include "game.h"
+#include "renderer.h"
+#include "progressstore.h"
+#include "camera.h"
+#include "resources.h"
 
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <string>
+#include <chrono>
 
 int const WINDOW_WIDTH = 800;
 int const WINDOW_HEIGHT = 480;
+// Headless runs step time by a fixed amount and stop on their own
+float const HEADLESS_TIMESTEP = 1.0f / 60.0f;
+unsigned long int const HEADLESS_FRAMES = 3600;
 
 bool RUNNING = true;
 
 void errorCallback(int code, char const* message);
 void windowCloseCallback(GLFWwindow* window);
 void windowSizeCallback(GLFWwindow *handle, int width, int height);
-void gameloop(glfwContext& ctx);
+void gameloop(glfwContext& ctx, Renderer& renderer, unsigned long int const maxFrames, unsigned long int const levelFrames, float const timeScale);
+double currentTime(glfwContext const& ctx);
+bool parseRendererType(int argc, char** argv, Renderer::Type& type);
+bool optionValue(int argc, char** argv, std::string const& option, std::string& value);
+bool hasOption(int argc, char** argv, std::string const& option);
 int main(int argc, char** argv)
 {
+  Renderer::Type rendererType = Renderer::DISPLAY;
+  if(!parseRendererType(argc, argv, rendererType))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Without a window nothing else ends a headless run, so it always has a frame limit
+  std::string frames;
+  unsigned long int maxFrames = optionValue(argc, argv, "--frames=", frames) ? std::strtoul(frames.data(), nullptr, 10) : 0;
+  if(rendererType == Renderer::NONE && maxFrames == 0)
+  {
+    maxFrames = HEADLESS_FRAMES;
+  }
+
+  // Leaves unsolved levels after this many frames, so a short run still
+  // loads and tears down several of them
+  std::string levelFramesValue;
+  unsigned long int const levelFrames = optionValue(argc, argv, "--level-frames=", levelFramesValue) ? std::strtoul(levelFramesValue.data(), nullptr, 10) : 0;
+
+  std::string timeScaleValue;
+  float const timeScale = optionValue(argc, argv, "--time-scale=", timeScaleValue) ? std::strtof(timeScaleValue.data(), nullptr) : 1.0f;
+  if(!(timeScale > 0.0f))
+  {
+    std::cerr << "Time scale must be a positive number" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  setStrictResources(hasOption(argc, argv, "--strict-resources"));
+
+  // The null renderer runs headless: no window, no GL context and a scripted scene
+  if(rendererType == Renderer::NONE)
+  {
+    glfwContext ctx(nullptr);
+    ctx.width = WINDOW_WIDTH;
+    ctx.height = WINDOW_HEIGHT;
+
+    if(!glhckContextCreate(argc, argv))
+    {
+      std::cerr << "Failed to create a GLhck context" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    glhckLogColor(0);
+    if(!glhckDisplayCreate(WINDOW_WIDTH, WINDOW_HEIGHT, GLHCK_RENDER_STUB))
+    {
+      std::cerr << "Failed to create a GLhck display" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    Renderer* renderer = newRenderer(rendererType, WINDOW_WIDTH, WINDOW_HEIGHT);
+    gameloop(ctx, *renderer, maxFrames, levelFrames, timeScale);
+    delete renderer;
+
+    glhckContextTerminate();
+    return EXIT_SUCCESS;
+  }
+
   if (!glfwInit())
   {
     std::cerr << "GLFW initialization error" << std::endl;
@@ -40,6 +110,9 @@ int main(int argc, char** argv)
   if(features.render.opengl) {
     glfwWindowHint(GLFW_DEPTH_BITS, 24);
   }
+  if(rendererType == Renderer::OFFSCREEN) {
+    glfwWindowHint(GLFW_VISIBLE, 0);
+  }
 
   GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "qb", NULL, NULL);
 
@@ -49,6 +122,7 @@ int main(int argc, char** argv)
   }
 
   glfwContext ctx(window);
+  glfwGetWindowSize(window, &ctx.width, &ctx.height);
 
   glfwSetWindowUserPointer(window, &ctx);
 
@@ -57,7 +131,7 @@ int main(int argc, char** argv)
   glfwSetWindowCloseCallback(window, windowCloseCallback);
   glfwSetWindowSizeCallback(window, windowSizeCallback);
 
-  glfwSwapInterval(1);
+  glfwSwapInterval(rendererType == Renderer::DISPLAY ? 1 : 0);
 
   if(!glhckContextCreate(argc, argv))
   {
@@ -74,13 +148,74 @@ int main(int argc, char** argv)
 
   glhckRenderClearColorb(64, 64, 64, 255);
 
-  gameloop(ctx);
+  Renderer* renderer = newRenderer(rendererType, WINDOW_WIDTH, WINDOW_HEIGHT);
+  if(!renderer)
+  {
+    std::cerr << "Failed to create " << rendererName(rendererType) << " renderer" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  gameloop(ctx, *renderer, maxFrames, levelFrames, timeScale);
+
+  delete renderer;
 
   glhckContextTerminate();
   glfwTerminate();
   return EXIT_SUCCESS;
 }
 
+bool parseRendererType(int argc, char** argv, Renderer::Type& type)
+{
+  std::string value;
+  if(!optionValue(argc, argv, "--renderer=", value) || value == "display")
+  {
+    type = Renderer::DISPLAY;
+  }
+  else if(value == "offscreen")
+  {
+    type = Renderer::OFFSCREEN;
+  }
+  else if(value == "null")
+  {
+    type = Renderer::NONE;
+  }
+  else
+  {
+    std::cerr << "Unknown renderer " << value << ", expected display, offscreen or null" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool optionValue(int argc, char** argv, std::string const& option, std::string& value)
+{
+  for(int i = 1; i < argc; ++i)
+  {
+    std::string const arg = argv[i];
+    if(arg.compare(0, option.size(), option) == 0)
+    {
+      value = arg.substr(option.size());
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool hasOption(int argc, char** argv, std::string const& option)
+{
+  for(int i = 1; i < argc; ++i)
+  {
+    if(option == argv[i])
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 void errorCallback(int code, char const* message)
 {
   std::cerr << "GLFW ERROR: " << message << std::endl;
@@ -94,55 +229,117 @@ void windowCloseCallback(GLFWwindow* window)
 
 void windowSizeCallback(GLFWwindow *window, int width, int height)
 {
+  glfwContext* ctx = static_cast<glfwContext*>(glfwGetWindowUserPointer(window));
+  ctx->width = width;
+  ctx->height = height;
   glhckDisplayResize(width, height);
 }
 
-void gameloop(glfwContext& ctx)
+double currentTime(glfwContext const& ctx)
+{
+  if(ctx.window)
+  {
+    return glfwGetTime();
+  }
+
+  static std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void gameloop(glfwContext& ctx, Renderer& renderer, unsigned long int const maxFrames, unsigned long int const levelFrames, float const timeScale)
 {
   float const FPS_INTERVAL = 5.0f;
-  float const START_TIME = glfwGetTime();
+  float const START_TIME = currentTime(ctx);
 
   LevelPack levelPack("levels/AlbertoG_Plus2.txt");
+  ProgressStore progress("progress.txt");
 
-  int levelNum = 0;
+  int levelNum = progress.solvedPrefix(levelPack.getName());
+  if(levelNum >= levelPack.size())
+  {
+    levelNum = 0;
+  }
+
+  CameraController camera;
   Game* game = nullptr;
+  unsigned long int levelStartFrame = 0;
+  bool reportKeyDown = false;
 
-  while(ctx.running && levelNum < levelPack.size())
+  while(ctx.running && levelNum < levelPack.size() && (maxFrames == 0 || ctx.frame < maxFrames))
   {
-    float const frameStartTime = glfwGetTime();
-    ctx.deltaTime = frameStartTime - ctx.previousFrameStartTime;
-    ctx.fpsTime += ctx.deltaTime;
+    float const frameStartTime = currentTime(ctx);
+    float const wallDeltaTime = frameStartTime - ctx.previousFrameStartTime;
+    ctx.deltaTime = ctx.window ? wallDeltaTime : HEADLESS_TIMESTEP;
+    ctx.fpsTime += wallDeltaTime;
     ctx.totalTime = frameStartTime - START_TIME;
 
     if(ctx.fpsTime >= FPS_INTERVAL)
     {
       ctx.fps = ctx.fpsFrame / ctx.fpsTime;
+
+      if(renderer.getType() != Renderer::DISPLAY && renderer.getStatistics().frames > 0)
+      {
+        Renderer::Statistics const& statistics = renderer.getStatistics();
+        std::cout << rendererName(renderer.getType()) << ": " << ctx.fps << " fps, "
+                  << statistics.frameTime * 1000.0f / statistics.frames << " ms/frame, "
+                  << statistics.draws / statistics.frames << " draws/frame, "
+                  << statistics.triangles / statistics.frames << " triangles/frame" << std::endl;
+        renderer.resetStatistics();
+      }
+
       ctx.fpsFrame = 0;
       ctx.fpsTime = 0.0f;
     }
 
-    glfwPollEvents();
+    if(ctx.window)
+    {
+      glfwPollEvents();
+
+      bool const reportKey = glfwGetKey(ctx.window, GLFW_KEY_F2);
+      if(reportKey && !reportKeyDown)
+      {
+        reportResources(std::cout);
+      }
+      reportKeyDown = reportKey;
+    }
 
     if(game == nullptr)
     {
-      game = newGame(levelPack.getLevel(levelNum));
+      game = newGame(levelPack.getLevel(levelNum), camera);
+      setGameTimeScale(game, timeScale);
+      levelStartFrame = ctx.frame;
     }
 
-    playGame(game, ctx);
+    playGame(game, ctx, renderer);
 
-    glhckRender();
-
-    if(gameFinished(game))
+    bool const finished = gameFinished(game);
+    if(finished || (levelFrames > 0 && ctx.frame + 1 - levelStartFrame >= levelFrames))
     {
+      if(finished)
+      {
+        GameStatistics const& statistics = getGameStatistics(game);
+        ProgressStore::Record solve;
+        solve.moves = statistics.moves;
+        solve.pushes = statistics.pushes;
+        solve.time = statistics.time;
+        solve.solution = statistics.solution;
+        progress.record(levelPack.getName(), levelNum, solve);
+      }
+
       endGame(game);
+      checkResourcesReleased("level teardown");
       levelNum += 1;
       game = nullptr;
     }
 
-    float const frameEndTime = glfwGetTime();
+    float const frameEndTime = currentTime(ctx);
     ctx.previousFrameDuration = frameEndTime - frameStartTime;
+    renderer.countFrameTime(ctx.previousFrameDuration);
 
-    glfwSwapBuffers(ctx.window);
+    if(ctx.window)
+    {
+      glfwSwapBuffers(ctx.window);
+    }
     ctx.previousFrameStartTime = frameStartTime;
     ctx.frame += 1;
     ctx.fpsFrame += 1;
@@ -151,5 +348,6 @@ void gameloop(glfwContext& ctx)
   if(game != nullptr)
   {
     endGame(game);
+    checkResourcesReleased("level teardown");
   }
 }
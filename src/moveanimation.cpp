@@ -0,0 +1,107 @@
+#include "moveanimation.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+  float progress(float const time, float const start, float const duration)
+  {
+    if(duration <= 0.0f)
+      return time >= start ? 1.0f : 0.0f;
+
+    return std::min(std::max((time - start) / duration, 0.0f), 1.0f);
+  }
+}
+
+MoveAnimation::MoveAnimation() : tracks(), numTracks(0), duration(0.0f), clipName(nullptr), clipDuration(0.0f)
+{
+}
+
+MoveAnimation& MoveAnimation::track(const MoveAnimation::Target target, const float start, const float duration, const float delta)
+{
+  if(delta == 0.0f)
+    return *this;
+
+  if(numTracks == MAX_TRACKS)
+  {
+    throw std::length_error("Too many move animation tracks");
+  }
+
+  tracks[numTracks++] = { target, start, duration, delta };
+  this->duration = std::max(this->duration, start + duration);
+  return *this;
+}
+
+MoveAnimation& MoveAnimation::clip(const char* name, const float duration)
+{
+  clipName = name;
+  clipDuration = duration;
+  return *this;
+}
+
+float MoveAnimation::getDuration() const
+{
+  return duration;
+}
+
+const char* MoveAnimation::getClip() const
+{
+  return clipName;
+}
+
+float MoveAnimation::getClipDuration() const
+{
+  return clipDuration;
+}
+
+void MoveAnimation::apply(glhckObject* object, const float from, const float to) const
+{
+  kmVec3 position = *glhckObjectGetPosition(object);
+  kmVec3 rotation = *glhckObjectGetRotation(object);
+
+  for(int i = 0; i < numTracks; ++i)
+  {
+    Track const& t = tracks[i];
+    float const change = t.delta * (progress(to, t.start, t.duration) - progress(from, t.start, t.duration));
+    switch(t.target)
+    {
+      case X: position.x += change; break;
+      case Z: position.z += change; break;
+      case ROTATION_Y: rotation.y += change; break;
+    }
+  }
+
+  glhckObjectPositionf(object, position.x, position.y, position.z);
+  glhckObjectRotationf(object, rotation.x, rotation.y, rotation.z);
+}
+
+MoveAnimator::MoveAnimator() : animation(nullptr), time(0.0f)
+{
+}
+
+void MoveAnimator::start(const MoveAnimation& animation)
+{
+  this->animation = &animation;
+  time = 0.0f;
+}
+
+bool MoveAnimator::running() const
+{
+  return animation != nullptr;
+}
+
+bool MoveAnimator::animate(glhckObject* object, const float delta)
+{
+  if(!animation)
+    return false;
+
+  float const next = std::min(time + delta, animation->getDuration());
+  animation->apply(object, time, next);
+  time = next;
+
+  if(time < animation->getDuration())
+    return false;
+
+  animation = nullptr;
+  return true;
+}
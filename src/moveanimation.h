@@ -0,0 +1,59 @@
+#ifndef MOVEANIMATION_H
+#define MOVEANIMATION_H
+
+#include "glhck/glhck.h"
+
+// Immutable description of a move as linear tracks on an object's transform.
+// Built once and shared, playing one needs only a MoveAnimator.
+class MoveAnimation
+{
+public:
+  enum Target { X, Z, ROTATION_Y };
+
+  MoveAnimation();
+
+  MoveAnimation& track(Target const target, float const start, float const duration, float const delta);
+  MoveAnimation& clip(char const* name, float const duration);
+
+  float getDuration() const;
+  char const* getClip() const;
+  float getClipDuration() const;
+
+  // Applies the change in transform between two points in time
+  void apply(glhckObject* object, float const from, float const to) const;
+
+private:
+  struct Track
+  {
+    Target target;
+    float start;
+    float duration;
+    float delta;
+  };
+
+  static int const MAX_TRACKS = 8;
+
+  Track tracks[MAX_TRACKS];
+  int numTracks;
+  float duration;
+  char const* clipName;
+  float clipDuration;
+};
+
+class MoveAnimator
+{
+public:
+  MoveAnimator();
+
+  void start(MoveAnimation const& animation);
+  bool running() const;
+
+  // Returns true on the step that finishes the animation
+  bool animate(glhckObject* object, float const delta);
+
+private:
+  MoveAnimation const* animation;
+  float time;
+};
+
+#endif // MOVEANIMATION_H
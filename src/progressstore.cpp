@@ -0,0 +1,324 @@
+#include "progressstore.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+  // Compact when the journal has this many more lines than live records
+  unsigned int const COMPACT_SLACK = 64;
+
+  std::string sanitize(std::string value)
+  {
+    for(char& c : value)
+    {
+      if(c == '\t' || c == '\n')
+        c = ' ';
+    }
+    return value;
+  }
+
+  // Flushes a file or directory from the OS to the disk
+  bool sync(std::string const& path, int const flags)
+  {
+    int const fd = open(path.data(), flags);
+    if(fd < 0)
+      return false;
+
+    bool const synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+  }
+
+  bool syncFile(std::string const& filename)
+  {
+    return sync(filename, O_RDONLY);
+  }
+
+  // A rename or a new file only survives a power loss once its directory is synced
+  bool syncDirectory(std::string const& filename)
+  {
+    std::string::size_type const separator = filename.rfind('/');
+    std::string const directory = separator == std::string::npos ? "." : separator == 0 ? "/" : filename.substr(0, separator);
+    return sync(directory, O_RDONLY | O_DIRECTORY);
+  }
+
+  void writeLine(std::ostream& os, std::string const& pack, unsigned int const level, ProgressStore::Record const& r)
+  {
+    os << sanitize(pack) << '\t' << level << '\t' << r.moves << '\t'
+       << r.pushes << '\t' << r.time << '\t' << sanitize(r.solution) << '\n';
+  }
+}
+
+ProgressStore::ProgressStore(const std::string& filename) :
+  filename(filename), indexFilename(filename + ".index"), loaded(false), indexLoaded(false),
+  tornTail(false), journalEntries(0), records(), prefixes()
+{
+}
+
+const ProgressStore::Record* ProgressStore::getRecord(const std::string& pack, const unsigned int level)
+{
+  load();
+  auto const i = records.find(Key(sanitize(pack), level));
+  return i != records.end() ? &i->second : nullptr;
+}
+
+bool ProgressStore::solved(const std::string& pack, const unsigned int level)
+{
+  return getRecord(pack, level) != nullptr;
+}
+
+unsigned int ProgressStore::solvedPrefix(const std::string& pack)
+{
+  loadIndex();
+  auto const i = prefixes.find(sanitize(pack));
+  return i != prefixes.end() ? i->second : 0;
+}
+
+bool ProgressStore::record(const std::string& pack, const unsigned int level, const ProgressStore::Record& solve)
+{
+  load();
+  Key const key(sanitize(pack), level);
+  if(!merge(key, solve))
+  {
+    return false;
+  }
+
+  append(key, records.at(key));
+
+  if(journalEntries > records.size() + COMPACT_SLACK)
+  {
+    compact();
+  }
+
+  loadIndex();
+  unsigned int& prefix = prefixes[key.first];
+  unsigned int const previous = prefix;
+  while(records.count(Key(key.first, prefix)))
+  {
+    prefix += 1;
+  }
+  if(prefix != previous)
+  {
+    writeIndex();
+  }
+
+  return true;
+}
+
+bool ProgressStore::compact()
+{
+  load();
+  std::string const tmpFilename = filename + ".tmp";
+
+  {
+    std::ofstream ofs(tmpFilename, std::ios::trunc);
+    for(auto const& entry : records)
+    {
+      writeLine(ofs, entry.first.first, entry.first.second, entry.second);
+    }
+    ofs.close();
+    if(!ofs || !syncFile(tmpFilename))
+    {
+      std::cerr << "Failed to write " << tmpFilename << std::endl;
+      return false;
+    }
+  }
+
+  // The new contents are on disk before the rename, so replacing the journal
+  // leaves either the old or the new file even on a power loss
+  if(std::rename(tmpFilename.data(), filename.data()) != 0)
+  {
+    std::cerr << "Failed to replace " << filename << std::endl;
+    return false;
+  }
+  syncDirectory(filename);
+
+  journalEntries = records.size();
+  tornTail = false;
+  return true;
+}
+
+void ProgressStore::load()
+{
+  if(loaded)
+    return;
+
+  loaded = true;
+
+  std::ifstream ifs(filename);
+  std::string line;
+  while(std::getline(ifs, line))
+  {
+    // A line cut short by a crash has no terminating newline, skip it
+    if(ifs.eof())
+    {
+      tornTail = true;
+      break;
+    }
+
+    std::istringstream fields(line);
+    std::string pack;
+    std::string level;
+    std::string moves;
+    std::string pushes;
+    std::string time;
+    Record r;
+
+    if(std::getline(fields, pack, '\t') && std::getline(fields, level, '\t')
+       && std::getline(fields, moves, '\t') && std::getline(fields, pushes, '\t')
+       && std::getline(fields, time, '\t') && std::getline(fields, r.solution))
+    {
+      std::istringstream numbers(level + ' ' + moves + ' ' + pushes + ' ' + time);
+      unsigned int levelNum;
+      if(numbers >> levelNum >> r.moves >> r.pushes >> r.time)
+      {
+        merge(Key(pack, levelNum), r);
+      }
+    }
+
+    journalEntries += 1;
+  }
+
+  ifs.close();
+
+  // Drop the torn line before anything is appended after it
+  if(tornTail)
+  {
+    compact();
+  }
+}
+
+void ProgressStore::loadIndex()
+{
+  if(indexLoaded)
+    return;
+
+  indexLoaded = true;
+
+  std::ifstream ifs(indexFilename);
+  if(!ifs)
+  {
+    // No index yet, derive it from the journal once
+    load();
+    for(auto const& entry : records)
+    {
+      unsigned int& prefix = prefixes[entry.first.first];
+      while(records.count(Key(entry.first.first, prefix)))
+      {
+        prefix += 1;
+      }
+    }
+    if(!prefixes.empty())
+    {
+      writeIndex();
+    }
+    return;
+  }
+
+  std::string line;
+  while(std::getline(ifs, line))
+  {
+    std::string::size_type const separator = line.rfind('\t');
+    if(separator == std::string::npos)
+      continue;
+
+    std::istringstream number(line.substr(separator + 1));
+    unsigned int prefix;
+    if(number >> prefix)
+    {
+      prefixes[line.substr(0, separator)] = prefix;
+    }
+  }
+}
+
+bool ProgressStore::writeIndex()
+{
+  std::string const tmpFilename = indexFilename + ".tmp";
+
+  {
+    std::ofstream ofs(tmpFilename, std::ios::trunc);
+    for(auto const& entry : prefixes)
+    {
+      ofs << entry.first << '\t' << entry.second << '\n';
+    }
+    ofs.close();
+    if(!ofs || !syncFile(tmpFilename))
+    {
+      std::cerr << "Failed to write " << tmpFilename << std::endl;
+      return false;
+    }
+  }
+
+  if(std::rename(tmpFilename.data(), indexFilename.data()) != 0)
+  {
+    std::cerr << "Failed to replace " << indexFilename << std::endl;
+    return false;
+  }
+  syncDirectory(indexFilename);
+
+  return true;
+}
+
+bool ProgressStore::merge(const ProgressStore::Key& key, const ProgressStore::Record& solve)
+{
+  auto const i = records.find(key);
+  if(i == records.end())
+  {
+    records.insert(std::make_pair(key, solve));
+    return true;
+  }
+
+  Record& best = i->second;
+  bool improved = false;
+
+  if(solve.moves < best.moves)
+  {
+    best.moves = solve.moves;
+    best.solution = solve.solution;
+    improved = true;
+  }
+  if(solve.pushes < best.pushes)
+  {
+    best.pushes = solve.pushes;
+    improved = true;
+  }
+  if(solve.time < best.time)
+  {
+    best.time = solve.time;
+    improved = true;
+  }
+
+  return improved;
+}
+
+void ProgressStore::append(const ProgressStore::Key& key, const ProgressStore::Record& record)
+{
+  std::ofstream ofs(filename, std::ios::app);
+  if(tornTail)
+  {
+    // Compaction failed to drop a torn line, end it so this record stands alone
+    ofs << '\n';
+    tornTail = false;
+  }
+  writeLine(ofs, key.first, key.second, record);
+  ofs.close();
+
+  if(!ofs || !syncFile(filename))
+  {
+    std::cerr << "Failed to write " << filename << std::endl;
+    return;
+  }
+
+  // The first entry may have created the journal
+  if(journalEntries == 0)
+  {
+    syncDirectory(filename);
+  }
+
+  journalEntries += 1;
+}
@@ -0,0 +1,57 @@
+#ifndef PROGRESSSTORE_H
+#define PROGRESSSTORE_H
+
+#include <map>
+#include <string>
+#include <utility>
+
+// Best results per pack and level, kept in an append-only journal file.
+// The journal is read on first use and rewritten once it holds mostly
+// superseded entries. Every write is synced to disk before it counts as
+// done, so the store survives power loss as well as crashes. A small index next to it holds the number of
+// leading solved levels per pack, so resuming does not read the journal.
+class ProgressStore
+{
+public:
+  struct Record
+  {
+    Record() : moves(0), pushes(0), time(0.0f), solution() {}
+    unsigned int moves;
+    unsigned int pushes;
+    float time;
+    std::string solution;
+  };
+
+  ProgressStore(std::string const& filename);
+
+  Record const* getRecord(std::string const& pack, unsigned int const level);
+  bool solved(std::string const& pack, unsigned int const level);
+  // Number of consecutive solved levels from the start of the pack
+  unsigned int solvedPrefix(std::string const& pack);
+
+  // Merges a solve into the level's best results and journals any improvement.
+  // Returns true if something improved.
+  bool record(std::string const& pack, unsigned int const level, Record const& solve);
+
+  bool compact();
+
+private:
+  typedef std::pair<std::string, unsigned int> Key;
+
+  void load();
+  void loadIndex();
+  bool writeIndex();
+  bool merge(Key const& key, Record const& solve);
+  void append(Key const& key, Record const& record);
+
+  std::string filename;
+  std::string indexFilename;
+  bool loaded;
+  bool indexLoaded;
+  bool tornTail;
+  unsigned int journalEntries;
+  std::map<Key, Record> records;
+  std::map<std::string, unsigned int> prefixes;
+};
+
+#endif // PROGRESSSTORE_H
@@ -0,0 +1,189 @@
+#include "renderer.h"
+
+namespace
+{
+  unsigned long int triangleCount(glhckObject const* object)
+  {
+    unsigned long int triangles = 0;
+    glhckGeometry const* geometry = glhckObjectGetGeometry(object);
+    if(geometry)
+    {
+      int const count = geometry->indexCount ? geometry->indexCount : geometry->vertexCount;
+      if(geometry->type == GLHCK_TRIANGLES)
+      {
+        triangles += count / 3;
+      }
+      else if(geometry->type == GLHCK_TRIANGLE_STRIP && count > 2)
+      {
+        triangles += count - 2;
+      }
+    }
+
+    unsigned int numChildren = 0;
+    glhckObject** children = glhckObjectChildren(object, &numChildren);
+    for(unsigned int i = 0; i < numChildren; ++i)
+    {
+      triangles += triangleCount(children[i]);
+    }
+
+    return triangles;
+  }
+
+  // Draws straight to the window through the glhck render queue
+  class DisplayRenderer : public Renderer
+  {
+  public:
+    Type getType() const
+    {
+      return DISPLAY;
+    }
+
+    void begin()
+    {
+      glhckRenderClear(GLHCK_DEPTH_BUFFER_BIT | GLHCK_COLOR_BUFFER_BIT);
+    }
+
+    void draw(glhckObject* object)
+    {
+      count(object);
+      glhckObjectDraw(object);
+    }
+
+    void end()
+    {
+      glhckRender();
+      statistics.frames += 1;
+    }
+  };
+
+  // Same as the display path but into a framebuffer that is never shown
+  class OffscreenRenderer : public DisplayRenderer
+  {
+  public:
+    OffscreenRenderer() : framebuffer(nullptr), color(nullptr), depth(nullptr) {}
+
+    ~OffscreenRenderer()
+    {
+      if(framebuffer) glhckFramebufferFree(framebuffer);
+      if(color) glhckTextureFree(color);
+      if(depth) glhckTextureFree(depth);
+    }
+
+    bool create(int const width, int const height)
+    {
+      color = glhckTextureNew();
+      depth = glhckTextureNew();
+      framebuffer = glhckFramebufferNew(GLHCK_FRAMEBUFFER);
+
+      if(!color || !depth || !framebuffer
+         || !glhckTextureCreate(color, GLHCK_TEXTURE_2D, 0, width, height, 0, 0, GLHCK_RGBA, GLHCK_UNSIGNED_BYTE, 0, nullptr)
+         || !glhckTextureCreate(depth, GLHCK_TEXTURE_2D, 0, width, height, 0, 0, GLHCK_DEPTH_COMPONENT, GLHCK_UNSIGNED_BYTE, 0, nullptr)
+         || !glhckFramebufferAttach(framebuffer, GLHCK_COLOR_ATTACHMENT0, color)
+         || !glhckFramebufferAttach(framebuffer, GLHCK_DEPTH_ATTACHMENT, depth))
+      {
+        return false;
+      }
+
+      glhckFramebufferRecti(framebuffer, 0, 0, width, height);
+      return true;
+    }
+
+    Type getType() const
+    {
+      return OFFSCREEN;
+    }
+
+    void begin()
+    {
+      glhckFramebufferBegin(framebuffer);
+      DisplayRenderer::begin();
+    }
+
+    void end()
+    {
+      DisplayRenderer::end();
+      glhckFramebufferEnd(framebuffer);
+    }
+
+  private:
+    glhckFramebuffer* framebuffer;
+    glhckTexture* color;
+    glhckTexture* depth;
+  };
+
+  // Submits nothing, only counts what would have been drawn
+  class NullRenderer : public Renderer
+  {
+  public:
+    Type getType() const
+    {
+      return NONE;
+    }
+
+    void begin()
+    {
+    }
+
+    void draw(glhckObject* object)
+    {
+      count(object);
+    }
+
+    void end()
+    {
+      statistics.frames += 1;
+    }
+  };
+}
+
+Renderer::Statistics const& Renderer::getStatistics() const
+{
+  return statistics;
+}
+
+void Renderer::resetStatistics()
+{
+  statistics = Statistics();
+}
+
+void Renderer::countFrameTime(const float seconds)
+{
+  statistics.frameTime += seconds;
+}
+
+void Renderer::count(const glhckObject* object)
+{
+  statistics.draws += 1;
+  statistics.triangles += triangleCount(object);
+}
+
+Renderer* newRenderer(const Renderer::Type type, const int width, const int height)
+{
+  switch(type)
+  {
+    case Renderer::DISPLAY: return new DisplayRenderer;
+    case Renderer::OFFSCREEN:
+    {
+      OffscreenRenderer* renderer = new OffscreenRenderer;
+      if(!renderer->create(width, height))
+      {
+        delete renderer;
+        return nullptr;
+      }
+      return renderer;
+    }
+    case Renderer::NONE: return new NullRenderer;
+    default: return nullptr;
+  }
+}
+
+char const* rendererName(const Renderer::Type type)
+{
+  switch(type)
+  {
+    case Renderer::DISPLAY: return "display";
+    case Renderer::OFFSCREEN: return "offscreen";
+    case Renderer::NONE: return "null";
+    default: return "unknown";
+  }
+}
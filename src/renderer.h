@@ -0,0 +1,43 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "glhck/glhck.h"
+
+class Renderer
+{
+public:
+  enum Type { DISPLAY, OFFSCREEN, NONE };
+
+  struct Statistics
+  {
+    Statistics() : frames(0), draws(0), triangles(0), frameTime(0.0f) {}
+    unsigned long int frames;
+    unsigned long int draws;
+    unsigned long int triangles;
+    float frameTime;
+  };
+
+  virtual ~Renderer() {}
+
+  virtual Type getType() const = 0;
+  // The camera is applied by the caller, see CameraController
+  virtual void begin() = 0;
+  virtual void draw(glhckObject* object) = 0;
+  virtual void end() = 0;
+
+  Statistics const& getStatistics() const;
+  void resetStatistics();
+  // CPU time spent on a whole frame, measured by the caller
+  void countFrameTime(float const seconds);
+
+protected:
+  void count(glhckObject const* object);
+
+  Statistics statistics;
+};
+
+// Returns nullptr if the backend could not be set up
+Renderer* newRenderer(Renderer::Type const type, int const width, int const height);
+char const* rendererName(Renderer::Type const type);
+
+#endif // RENDERER_H
@@ -0,0 +1,328 @@
+#include "resources.h"
+#include <cstdlib>
+#include <iomanip>
+#include <unordered_map>
+
+namespace
+{
+  std::size_t const VERTEX_BYTES = 32;
+  std::size_t const INDEX_BYTES = 4;
+  std::size_t const TEXEL_BYTES = 4;
+
+  char const* const TYPE_NAMES[] = { "objects", "textures", "materials", "animations" };
+  char const* const OWNER_NAMES[] = { "floor", "wall", "target", "player", "box" };
+
+  struct Record
+  {
+    Resource::Type type;
+    Resource::Owner owner;
+    void const* handle;
+    std::size_t bytes;
+  };
+
+  struct Totals
+  {
+    unsigned long int count;
+    unsigned long int references;
+    std::size_t bytes;
+  };
+
+  // A glhck handle with the owner and size it was first tracked with
+  struct Handle
+  {
+    Resource::Type type;
+    Resource::Owner owner;
+    std::size_t bytes;
+    unsigned int references;
+  };
+
+  // Records are keyed by the handle the game will release, so resources
+  // held through an object are filed under that object
+  std::unordered_multimap<void const*, Record> records;
+  // Every glhck handle the records refer to. Shared handles such as cached
+  // textures are counted once, and their number of records is how many
+  // references glhck should still hold once the game lets go of one.
+  std::unordered_map<void const*, Handle> handles;
+  Totals totals[Resource::NUM_TYPES][Resource::NUM_OWNERS] = {};
+  unsigned long int leaks[Resource::NUM_TYPES][Resource::NUM_OWNERS] = {};
+  unsigned long int live = 0;
+  bool strict = false;
+
+  void add(void const* key, Record const& record)
+  {
+    records.insert(std::make_pair(key, record));
+
+    Handle& handle = handles[record.handle];
+    if(handle.references == 0)
+    {
+      handle = { record.type, record.owner, record.bytes, 0 };
+      totals[handle.type][handle.owner].count += 1;
+      totals[handle.type][handle.owner].bytes += handle.bytes;
+      live += 1;
+    }
+    handle.references += 1;
+    totals[handle.type][handle.owner].references += 1;
+  }
+
+  void remove(std::unordered_multimap<void const*, Record>::iterator i)
+  {
+    auto const h = handles.find(i->second.handle);
+    Handle const& handle = h->second;
+    totals[handle.type][handle.owner].references -= 1;
+    if(handle.references == 1)
+    {
+      totals[handle.type][handle.owner].count -= 1;
+      totals[handle.type][handle.owner].bytes -= handle.bytes;
+      live -= 1;
+      handles.erase(h);
+    }
+    else
+    {
+      h->second.references -= 1;
+    }
+    records.erase(i);
+  }
+
+  unsigned int expectedReferences(void const* handle)
+  {
+    auto const h = handles.find(handle);
+    return h != handles.end() ? h->second.references : 0;
+  }
+
+  // Compares the reference count a glhck free call returned against the
+  // records still held, anything more is held by someone the ledger does
+  // not know about and counts as leaked
+  void verify(Resource::Type const type, Resource::Owner const owner, void const* handle, unsigned int const remaining)
+  {
+    unsigned int const expected = expectedReferences(handle);
+    if(remaining > expected)
+    {
+      std::cerr << "Leaked " << remaining - expected << " references to " << TYPE_NAMES[type]
+                << " " << handle << std::endl;
+      leaks[type][owner] += remaining - expected;
+      live += remaining - expected;
+    }
+  }
+
+  // Finds the owner of a record about to be released
+  bool findOwner(Resource::Type const type, void const* key, Resource::Owner& owner)
+  {
+    auto const range = records.equal_range(key);
+    for(auto i = range.first; i != range.second; ++i)
+    {
+      if(i->second.type == type)
+      {
+        owner = i->second.owner;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::size_t geometryBytes(glhckObject const* object)
+  {
+    std::size_t bytes = 0;
+    glhckGeometry const* geometry = glhckObjectGetGeometry(object);
+    if(geometry)
+    {
+      bytes += geometry->vertexCount * VERTEX_BYTES + geometry->indexCount * INDEX_BYTES;
+    }
+
+    unsigned int numChildren = 0;
+    glhckObject** children = glhckObjectChildren(object, &numChildren);
+    for(unsigned int i = 0; i < numChildren; ++i)
+    {
+      bytes += geometryBytes(children[i]);
+    }
+
+    return bytes;
+  }
+
+  std::size_t textureBytes(glhckTexture* texture)
+  {
+    glhckTextureTarget target;
+    int width = 0;
+    int height = 0;
+    int depth = 0;
+    int border = 0;
+    glhckTextureFormat format;
+    glhckDataType dataType;
+    glhckTextureGetInformation(texture, &target, &width, &height, &depth, &border, &format, &dataType);
+    return width * height * (depth > 0 ? depth : 1) * TEXEL_BYTES;
+  }
+}
+
+void trackResource(const Resource::Type type, const Resource::Owner owner, const void* handle, const std::size_t bytes)
+{
+  add(handle, { type, owner, handle, bytes });
+}
+
+void releaseResource(const Resource::Type type, const void* handle)
+{
+  auto const range = records.equal_range(handle);
+  for(auto i = range.first; i != range.second; ++i)
+  {
+    if(i->second.type == type)
+    {
+      remove(i);
+      return;
+    }
+  }
+
+  std::cerr << "Released untracked " << TYPE_NAMES[type] << " " << handle << std::endl;
+}
+
+glhckObject* trackObject(glhckObject* object, const Resource::Owner owner)
+{
+  add(object, { Resource::OBJECT, owner, object, geometryBytes(object) });
+
+  glhckMaterial* material = glhckObjectGetMaterial(object);
+  if(material)
+  {
+    add(object, { Resource::MATERIAL, owner, material, 0 });
+    glhckTexture* texture = glhckMaterialGetTexture(material);
+    if(texture)
+    {
+      add(object, { Resource::TEXTURE, owner, texture, textureBytes(texture) });
+    }
+  }
+
+  return object;
+}
+
+glhckTexture* trackTexture(glhckTexture* texture, const Resource::Owner owner)
+{
+  trackResource(Resource::TEXTURE, owner, texture, textureBytes(texture));
+  return texture;
+}
+
+glhckMaterial* trackMaterial(glhckMaterial* material, const Resource::Owner owner)
+{
+  trackResource(Resource::MATERIAL, owner, material);
+  return material;
+}
+
+void freeObject(glhckObject* object)
+{
+  Resource::Owner owner = Resource::NUM_OWNERS;
+  if(!findOwner(Resource::OBJECT, object, owner))
+  {
+    std::cerr << "Released untracked " << TYPE_NAMES[Resource::OBJECT] << " " << object << std::endl;
+    glhckObjectFree(object);
+    return;
+  }
+
+  // Hold on to the material and texture so their counts can still be read
+  // after the object has dropped its references to them
+  glhckMaterial* material = glhckObjectGetMaterial(object);
+  glhckTexture* texture = material ? glhckMaterialGetTexture(material) : nullptr;
+  if(material)
+    glhckMaterialRef(material);
+  if(texture)
+    glhckTextureRef(texture);
+
+  auto range = records.equal_range(object);
+  while(range.first != range.second)
+  {
+    remove(range.first++);
+  }
+
+  verify(Resource::OBJECT, owner, object, glhckObjectFree(object));
+  if(material)
+    verify(Resource::MATERIAL, owner, material, glhckMaterialFree(material));
+  if(texture)
+    verify(Resource::TEXTURE, owner, texture, glhckTextureFree(texture));
+}
+
+void freeTexture(glhckTexture* texture)
+{
+  Resource::Owner owner = Resource::NUM_OWNERS;
+  bool const tracked = findOwner(Resource::TEXTURE, texture, owner);
+  releaseResource(Resource::TEXTURE, texture);
+  unsigned int const remaining = glhckTextureFree(texture);
+  if(tracked)
+    verify(Resource::TEXTURE, owner, texture, remaining);
+}
+
+void freeMaterial(glhckMaterial* material)
+{
+  Resource::Owner owner = Resource::NUM_OWNERS;
+  bool const tracked = findOwner(Resource::MATERIAL, material, owner);
+  releaseResource(Resource::MATERIAL, material);
+  unsigned int const remaining = glhckMaterialFree(material);
+  if(tracked)
+    verify(Resource::MATERIAL, owner, material, remaining);
+}
+
+void trackAnimation(const Resource::Owner owner)
+{
+  totals[Resource::ANIMATION][owner].count += 1;
+  totals[Resource::ANIMATION][owner].references += 1;
+  live += 1;
+}
+
+void releaseAnimation(const Resource::Owner owner)
+{
+  Totals& t = totals[Resource::ANIMATION][owner];
+  if(t.count == 0)
+  {
+    std::cerr << "Released untracked " << TYPE_NAMES[Resource::ANIMATION] << " of " << OWNER_NAMES[owner] << std::endl;
+    return;
+  }
+
+  t.count -= 1;
+  t.references -= 1;
+  live -= 1;
+}
+
+unsigned long int liveResources()
+{
+  return live;
+}
+
+void reportResources(std::ostream& os)
+{
+  os << "Live resources: " << live << std::endl;
+  for(int type = 0; type < Resource::NUM_TYPES; ++type)
+  {
+    for(int owner = 0; owner < Resource::NUM_OWNERS; ++owner)
+    {
+      Totals const& t = totals[type][owner];
+      if(t.count > 0)
+      {
+        os << "  " << std::setw(10) << std::left << TYPE_NAMES[type]
+           << std::setw(8) << OWNER_NAMES[owner]
+           << std::setw(8) << std::right << t.count
+           << std::setw(8) << t.references << " refs"
+           << std::setw(12) << t.bytes << " bytes" << std::endl;
+      }
+      if(leaks[type][owner] > 0)
+      {
+        os << "  " << std::setw(10) << std::left << TYPE_NAMES[type]
+           << std::setw(8) << OWNER_NAMES[owner]
+           << std::setw(8) << std::right << leaks[type][owner]
+           << " leaked references" << std::endl;
+      }
+    }
+  }
+}
+
+void setStrictResources(const bool enabled)
+{
+  strict = enabled;
+}
+
+bool strictResources()
+{
+  return strict;
+}
+
+void checkResourcesReleased(const char* when)
+{
+  if(!strict || live == 0)
+    return;
+
+  std::cerr << "Resources still live after " << when << std::endl;
+  reportResources(std::cerr);
+  std::abort();
+}
@@ -0,0 +1,47 @@
+#ifndef RESOURCES_H
+#define RESOURCES_H
+
+#include "glhck/glhck.h"
+#include <cstddef>
+#include <iostream>
+
+// Accounting of glhck and gas resources held by the game. Every reference
+// the game takes is recorded with the kind of thing that owns it, and
+// released again when the game lets go of it.
+struct Resource
+{
+  enum Type { OBJECT, TEXTURE, MATERIAL, ANIMATION, NUM_TYPES };
+  enum Owner { FLOOR, WALL, TARGET, PLAYER, BOX, NUM_OWNERS };
+};
+
+void trackResource(Resource::Type const type, Resource::Owner const owner, void const* handle, std::size_t const bytes = 0);
+void releaseResource(Resource::Type const type, void const* handle);
+
+// Records an object together with the material and texture it holds
+glhckObject* trackObject(glhckObject* object, Resource::Owner const owner);
+glhckTexture* trackTexture(glhckTexture* texture, Resource::Owner const owner);
+glhckMaterial* trackMaterial(glhckMaterial* material, Resource::Owner const owner);
+
+// References glhck still reports after a free beyond what the ledger
+// holds are counted as leaked and stay live
+void freeObject(glhckObject* object);
+void freeTexture(glhckTexture* texture);
+void freeMaterial(glhckMaterial* material);
+
+// Animations come and go with every move, so they are only counted per
+// owner and tracking them never allocates
+void trackAnimation(Resource::Owner const owner);
+void releaseAnimation(Resource::Owner const owner);
+
+// Number of distinct live resources plus leaked references
+unsigned long int liveResources();
+// Lists each distinct resource once with the references the game holds to
+// it. Bytes are estimates from texture dimensions and vertex counts.
+void reportResources(std::ostream& os);
+
+// In strict mode checkResourcesReleased() aborts unless nothing is live
+void setStrictResources(bool const enabled);
+bool strictResources();
+void checkResourcesReleased(char const* when);
+
+#endif // RESOURCES_H
@@ -0,0 +1,188 @@
+#include "solver.h"
+#include <cstring>
+#include <queue>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+namespace
+{
+  int const DELTA_X[] = { 0, 0, -1, 1 };
+  int const DELTA_Y[] = { -1, 1, 0, 0 };
+
+  struct Node
+  {
+    std::string state;
+    int parent;
+    Board::Push push;
+  };
+
+  // Box rows followed by the top-left reachable square, which stands for
+  // every player position within the same reachable area
+  std::string stateKey(Board const& board, Bitboard const& reach)
+  {
+    unsigned int const height = board.boxes.getHeight();
+    std::string key(height * sizeof(std::uint64_t) + 2, '\0');
+    std::memcpy(&key[0], board.boxes.data(), height * sizeof(std::uint64_t));
+
+    for(int y = 0; y < height; ++y)
+    {
+      std::uint64_t const r = reach.row(y);
+      if(r)
+      {
+        int x = 0;
+        while(!((r >> x) & 1))
+          ++x;
+        key[key.size() - 2] = static_cast<char>(x);
+        key[key.size() - 1] = static_cast<char>(y);
+        break;
+      }
+    }
+
+    return key;
+  }
+
+  void restoreState(Board& board, std::string const& key)
+  {
+    std::memcpy(board.boxes.data(), key.data(), board.boxes.getHeight() * sizeof(std::uint64_t));
+    board.playerX = static_cast<unsigned char>(key[key.size() - 2]);
+    board.playerY = static_cast<unsigned char>(key[key.size() - 1]);
+  }
+
+  unsigned int countBoxLines(std::vector<Board::Push> const& solution)
+  {
+    unsigned int lines = 0;
+    for(int i = 0; i < solution.size(); ++i)
+    {
+      Board::Push const& push = solution.at(i);
+      if(i == 0)
+      {
+        lines += 1;
+        continue;
+      }
+
+      Board::Push const& previous = solution.at(i - 1);
+      bool const sameBox = previous.x + DELTA_X[previous.direction] == push.x
+          && previous.y + DELTA_Y[previous.direction] == push.y;
+      if(!sameBox || previous.direction != push.direction)
+      {
+        lines += 1;
+      }
+    }
+    return lines;
+  }
+}
+
+bool boardSolved(const Board& board)
+{
+  for(int y = 0; y < board.boxes.getHeight(); ++y)
+  {
+    if(board.boxes.row(y) & ~board.targets.row(y))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+Bitboard liveSquares(const Board& board)
+{
+  Bitboard live(board.floor.getWidth(), board.floor.getHeight());
+  std::queue<std::pair<int, int>> queue;
+
+  for(int y = 0; y < board.targets.getHeight(); ++y)
+  {
+    for(int x = 0; x < board.targets.getWidth(); ++x)
+    {
+      if(board.targets.get(x, y))
+      {
+        live.set(x, y);
+        queue.push(std::make_pair(x, y));
+      }
+    }
+  }
+
+  // Pull boxes away from the targets: the box steps onto the player's
+  // square and the player steps back once more
+  while(!queue.empty())
+  {
+    std::pair<int, int> const box = queue.front();
+    queue.pop();
+
+    for(int d = Board::UP; d <= Board::RIGHT; ++d)
+    {
+      int const x = box.first + DELTA_X[d];
+      int const y = box.second + DELTA_Y[d];
+      if(board.floor.get(x, y) && board.floor.get(x + DELTA_X[d], y + DELTA_Y[d]) && !live.get(x, y))
+      {
+        live.set(x, y);
+        queue.push(std::make_pair(x, y));
+      }
+    }
+  }
+
+  return live;
+}
+
+SolverResult solve(const Board& board, const unsigned long int maxNodes)
+{
+  SolverResult result;
+  Bitboard const live = liveSquares(board);
+
+  Board current = board;
+  std::vector<Node> nodes;
+  std::unordered_set<std::string> visited;
+
+  nodes.push_back({ stateKey(current, reachable(current)), -1, { 0, 0, Board::UP } });
+  visited.insert(nodes.back().state);
+
+  int found = -1;
+  for(int i = 0; i < nodes.size() && result.nodes < maxNodes; ++i)
+  {
+    restoreState(current, nodes.at(i).state);
+    result.nodes += 1;
+
+    if(boardSolved(current))
+    {
+      found = i;
+      break;
+    }
+
+    Bitboard const reach = reachable(current);
+    for(Board::Push const& push : legalPushes(current, reach))
+    {
+      int const toX = push.x + DELTA_X[push.direction];
+      int const toY = push.y + DELTA_Y[push.direction];
+      if(!live.get(toX, toY))
+        continue;
+
+      Board next = current;
+      next.boxes.clear(push.x, push.y);
+      next.boxes.set(toX, toY);
+      next.playerX = push.x;
+      next.playerY = push.y;
+
+      std::string key = stateKey(next, reachable(next));
+      if(visited.find(key) != visited.end())
+        continue;
+
+      visited.insert(key);
+      nodes.push_back({ std::move(key), i, push });
+    }
+  }
+
+  if(found < 0)
+  {
+    return result;
+  }
+
+  for(int i = found; nodes.at(i).parent >= 0; i = nodes.at(i).parent)
+  {
+    result.solution.insert(result.solution.begin(), nodes.at(i).push);
+  }
+
+  result.solved = true;
+  result.pushes = result.solution.size();
+  result.boxLines = countBoxLines(result.solution);
+  return result;
+}
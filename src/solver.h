@@ -0,0 +1,27 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "bitboard.h"
+#include <vector>
+
+struct SolverResult
+{
+  SolverResult() : solved(false), nodes(0), pushes(0), boxLines(0), solution() {}
+  bool solved;
+  unsigned long int nodes;
+  unsigned int pushes;
+  // Number of runs of consecutive pushes on the same box in the same direction
+  unsigned int boxLines;
+  std::vector<Board::Push> solution;
+};
+
+// Breadth-first search over pushes, so a found solution has the fewest pushes.
+// Gives up unsolved after expanding maxNodes states.
+SolverResult solve(Board const& board, unsigned long int const maxNodes);
+
+// Squares from which a lone box can still be pushed onto some target
+Bitboard liveSquares(Board const& board);
+
+bool boardSolved(Board const& board);
+
+#endif // SOLVER_H
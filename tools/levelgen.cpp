@@ -0,0 +1,316 @@
+#include "levelpack.h"
+#include "bitboard.h"
+#include "solver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Generates rated levels from room templates by pulling boxes away from
+// their targets, then solving each candidate to rate it.
+//
+// Usage: levelgen [--templates=FILE] [--output=FILE] [--count=N] [--seed=N]
+//                 [--threads=N] [--min-pushes=N] [--max-nodes=N]
+
+struct Options
+{
+  Options() : templates("tools/rooms.txt"), output("generated.txt"), count(100), seed(1),
+    threads(std::max(1u, std::thread::hardware_concurrency())), minPushes(10), maxNodes(200000)
+  {
+  }
+
+  std::string templates;
+  std::string output;
+  unsigned int count;
+  unsigned long int seed;
+  unsigned int threads;
+  unsigned int minPushes;
+  unsigned long int maxNodes;
+};
+
+struct Candidate
+{
+  unsigned long int index;
+  int room;
+  Board board;
+  SolverResult result;
+  float difficulty;
+};
+
+int const DELTA_X[] = { 0, 0, -1, 1 };
+int const DELTA_Y[] = { -1, 1, 0, 0 };
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+  for(int i = 1; i < argc; ++i)
+  {
+    std::string const arg = argv[i];
+    std::string::size_type const separator = arg.find('=');
+    if(arg.compare(0, 2, "--") != 0 || separator == std::string::npos)
+    {
+      std::cerr << "Unknown argument " << arg << std::endl;
+      return false;
+    }
+
+    std::string const name = arg.substr(2, separator - 2);
+    std::string const value = arg.substr(separator + 1);
+    std::istringstream number(value);
+
+    if(name == "templates") options.templates = value;
+    else if(name == "output") options.output = value;
+    else if(name == "count") number >> options.count;
+    else if(name == "seed") number >> options.seed;
+    else if(name == "threads") number >> options.threads;
+    else if(name == "min-pushes") number >> options.minPushes;
+    else if(name == "max-nodes") number >> options.maxNodes;
+    else
+    {
+      std::cerr << "Unknown option " << name << std::endl;
+      return false;
+    }
+  }
+
+  options.threads = std::max(1u, options.threads);
+  return true;
+}
+
+std::vector<std::pair<int, int>> squares(Bitboard const& board)
+{
+  std::vector<std::pair<int, int>> result;
+  for(int y = 0; y < board.getHeight(); ++y)
+  {
+    for(int x = 0; x < board.getWidth(); ++x)
+    {
+      if(board.get(x, y))
+      {
+        result.push_back(std::make_pair(x, y));
+      }
+    }
+  }
+  return result;
+}
+
+// Walks backwards from the solved state: a pull moves a box onto the
+// player's square and the player one step further away
+bool reversePull(Board& board, std::mt19937& random, int const pulls)
+{
+  for(int i = 0; i < pulls; ++i)
+  {
+    Bitboard const reach = reachable(board, KERNEL_AUTO);
+    std::vector<Board::Push> moves;
+
+    for(std::pair<int, int> const& box : squares(board.boxes))
+    {
+      for(int d = Board::UP; d <= Board::RIGHT; ++d)
+      {
+        int const playerX = box.first + DELTA_X[d];
+        int const playerY = box.second + DELTA_Y[d];
+        int const backX = playerX + DELTA_X[d];
+        int const backY = playerY + DELTA_Y[d];
+        if(reach.get(playerX, playerY) && board.floor.get(backX, backY) && !board.boxes.get(backX, backY))
+        {
+          moves.push_back({ box.first, box.second, static_cast<Board::Direction>(d) });
+        }
+      }
+    }
+
+    if(moves.empty())
+    {
+      return i > 0;
+    }
+
+    Board::Push const& pull = moves.at(std::uniform_int_distribution<int>(0, moves.size() - 1)(random));
+    board.boxes.clear(pull.x, pull.y);
+    board.boxes.set(pull.x + DELTA_X[pull.direction], pull.y + DELTA_Y[pull.direction]);
+    board.playerX = pull.x + 2 * DELTA_X[pull.direction];
+    board.playerY = pull.y + 2 * DELTA_Y[pull.direction];
+  }
+
+  return true;
+}
+
+bool generate(LevelPack::Level const& room, std::mt19937& random, Board& board)
+{
+  board = newBoard(room);
+  board.boxes = Bitboard(room.width, room.height);
+  board.targets = Bitboard(room.width, room.height);
+
+  std::vector<std::pair<int, int>> floor = squares(board.floor);
+  if(floor.size() < 16)
+  {
+    return false;
+  }
+
+  int const boxCount = std::uniform_int_distribution<int>(2, std::min<int>(4, floor.size() / 8))(random);
+
+  std::shuffle(floor.begin(), floor.end(), random);
+  for(int i = 0; i < boxCount; ++i)
+  {
+    board.targets.set(floor.at(i).first, floor.at(i).second);
+    board.boxes.set(floor.at(i).first, floor.at(i).second);
+  }
+  board.playerX = floor.at(boxCount).first;
+  board.playerY = floor.at(boxCount).second;
+
+  if(!reversePull(board, random, std::uniform_int_distribution<int>(20, 80)(random)))
+  {
+    return false;
+  }
+
+  // Level files cannot express a box or the player standing on a target
+  std::vector<std::pair<int, int>> starts;
+  Bitboard const reach = reachable(board, KERNEL_AUTO);
+  for(std::pair<int, int> const& square : squares(reach))
+  {
+    if(!board.targets.get(square.first, square.second))
+    {
+      starts.push_back(square);
+    }
+  }
+  for(std::pair<int, int> const& box : squares(board.boxes))
+  {
+    if(board.targets.get(box.first, box.second))
+    {
+      return false;
+    }
+  }
+  if(starts.empty())
+  {
+    return false;
+  }
+
+  std::pair<int, int> const& start = starts.at(std::uniform_int_distribution<int>(0, starts.size() - 1)(random));
+  board.playerX = start.first;
+  board.playerY = start.second;
+  return true;
+}
+
+float rate(SolverResult const& result)
+{
+  return result.pushes + 2.0f * result.boxLines + std::log2(static_cast<float>(result.nodes));
+}
+
+void writeLevel(std::ostream& os, LevelPack::Level const& room, Candidate const& candidate, unsigned long int const seed)
+{
+  Board const& board = candidate.board;
+  for(int y = 0; y < room.height; ++y)
+  {
+    std::string row;
+    for(int x = 0; x < room.width; ++x)
+    {
+      bool const wall = y < room.tiles.size() && x < room.tiles.at(y).size()
+          && room.tiles.at(y).at(x) == LevelPack::Level::WALL;
+      if(wall) row += '#';
+      else if(board.boxes.get(x, y)) row += '$';
+      else if(board.targets.get(x, y)) row += '.';
+      else if(x == board.playerX && y == board.playerY) row += '@';
+      else row += ' ';
+    }
+    os << row.substr(0, row.find_last_not_of(' ') + 1) << '\n';
+  }
+
+  os << "; qb " << seed << "-" << candidate.index
+     << " difficulty " << static_cast<int>(candidate.difficulty)
+     << " (" << candidate.result.pushes << " pushes, "
+     << candidate.result.boxLines << " lines, "
+     << candidate.result.nodes << " nodes)\n\n";
+}
+
+int main(int argc, char** argv)
+{
+  Options options;
+  if(!parseOptions(argc, argv, options))
+  {
+    return EXIT_FAILURE;
+  }
+
+  LevelPack templates(options.templates);
+  std::vector<LevelPack::Level> rooms;
+  for(LevelPack::Level const& level : templates.getLevels())
+  {
+    if(level.height > 0 && level.width <= Bitboard::MAX_WIDTH)
+    {
+      rooms.push_back(level);
+    }
+  }
+
+  if(rooms.empty())
+  {
+    std::cerr << "No room templates in " << options.templates << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Each candidate draws from its own generator seeded by its index,
+  // so the output does not depend on thread scheduling
+  std::atomic<unsigned long int> nextIndex(0);
+  std::atomic<unsigned int> accepted(0);
+  std::mutex mutex;
+  std::vector<Candidate> candidates;
+
+  auto worker = [&]()
+  {
+    while(accepted < options.count)
+    {
+      unsigned long int const index = nextIndex++;
+      std::seed_seq seq{ options.seed, index };
+      std::mt19937 random(seq);
+
+      Candidate candidate;
+      candidate.index = index;
+      candidate.room = std::uniform_int_distribution<int>(0, rooms.size() - 1)(random);
+      if(!generate(rooms.at(candidate.room), random, candidate.board))
+        continue;
+
+      candidate.result = solve(candidate.board, options.maxNodes);
+      if(!candidate.result.solved || candidate.result.pushes < options.minPushes)
+        continue;
+
+      candidate.difficulty = rate(candidate.result);
+      std::lock_guard<std::mutex> lock(mutex);
+      candidates.push_back(std::move(candidate));
+      accepted += 1;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for(unsigned int i = 0; i < options.threads; ++i)
+  {
+    threads.push_back(std::thread(worker));
+  }
+  for(std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  std::sort(candidates.begin(), candidates.end(), [](Candidate const& a, Candidate const& b) {
+    return a.index < b.index;
+  });
+  candidates.resize(std::min<std::size_t>(candidates.size(), options.count));
+
+  std::ofstream ofs(options.output);
+  ofs << "; qb generated levels\n\n"
+      << "; Seed " << options.seed << ", " << candidates.size() << " levels\n\n";
+
+  for(Candidate const& candidate : candidates)
+  {
+    writeLevel(ofs, rooms.at(candidate.room), candidate, options.seed);
+  }
+
+  if(!ofs)
+  {
+    std::cerr << "Failed to write " << options.output << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Wrote " << candidates.size() << " levels to " << options.output << std::endl;
+  return EXIT_SUCCESS;
+}